@@ -20,26 +20,133 @@
 
 #include "BlinktPlugin.h"
 #include "blinkt_functions.h"
+#include "blinkt_lock.h"
 #include <wiringPi.h>
+#include <cmath>
+#include <chrono>
 
 
 unsigned BlinktPlugin::RefCount = 0;
 bool BlinktPlugin::ResetOnUnload = true;
-std::mutex BlinktPlugin::Mutex;
+std::thread BlinktPlugin::Clock;
+std::condition_variable BlinktPlugin::ClockCond;
+bool BlinktPlugin::ClockRunning = false;
+bool BlinktPlugin::ClockStopping = false;
+bool BlinktPlugin::Transitioning = false;
+bool BlinktPlugin::Dithering = false;
+bool BlinktPlugin::DitherEnabled = false;
+unsigned BlinktPlugin::FrameRate = 100;
+BlinktPlugin::ClockGuard BlinktPlugin::Guard;
+
+
+// Convert an angle in degrees to a fraction of a full turn in units of
+// 1/65536, as used by the blinkt_functions HSV functions. The result wraps
+// around, so this works for both hues and (negative) hue steps. Angles are
+// reduced to less than a full turn first so that the conversion to an
+// integer is always defined, and non-finite angles are treated as zero.
+static int32_t toHueUnits(double degrees) {
+	if (!std::isfinite(degrees)) {
+		return 0;
+	}
+	return (int32_t)std::floor(std::fmod(degrees, 360.0) / 360.0 * 65536.0 + 0.5);
+}
+
+// Convert a duration in milliseconds to the range used by blinkt_functions
+static uint32_t toDuration(int64_t ms) {
+	return ms <= 0 ? 0 : ms >= UINT32_MAX ? UINT32_MAX : (uint32_t)ms;
+}
+
+// Clamp a 16-bit output level to its valid range
+static uint16_t toLevel(int64_t level) {
+	return level <= 0 ? 0 : level >= UINT16_MAX ? UINT16_MAX : (uint16_t)level;
+}
+
+// Convert a saturation or value in the range 0.0-1.0 to 0-255
+static uint8_t toByte(double fraction) {
+	return fraction <= 0.0 ? 0 : fraction >= 1.0 ? 255 : (uint8_t)(fraction * 255.0 + 0.5);
+}
 
 
 BlinktPlugin::BlinktPlugin(): base_plugin_t("BlinktPlugin") {
 	// Nothing to do here except increment the reference count
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	RefCount++;
 }
 
 BlinktPlugin::~BlinktPlugin() {
-	// Maybe reset Blinkt! if the reference count reaches zero
-	std::lock_guard<std::mutex> lock(Mutex);
-	if (RefCount > 0 && --RefCount == 0 && ResetOnUnload) {
-		blinkt_reset();
+	// Stop the output clock and maybe reset Blinkt! if the reference
+	// count reaches zero
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	if (RefCount > 0 && --RefCount == 0) {
+		stopClock(lock);
+		if (ResetOnUnload) {
+			blinkt_reset();
+			blinkt_refresh();
+		}
+	}
+}
+
+
+// Output clock, which steps transitions and dithering and refreshes the LEDs
+// at a fixed frame rate while either is in progress, and sleeps otherwise.
+// The Clock thread object is only assigned or joined while ClockStopping is
+// false, so a new clock can't be started while an old one is being joined.
+
+void BlinktPlugin::startClock(std::unique_lock<std::mutex> &lock) {
+	ClockCond.wait(lock, [] { return !ClockStopping; });
+	if (!ClockRunning) {
+		ClockRunning = true;
+		Clock = std::thread(&BlinktPlugin::runClock);
+	}
+	ClockCond.notify_all();
+}
+
+void BlinktPlugin::stopClock(std::unique_lock<std::mutex> &lock) {
+	ClockCond.wait(lock, [] { return !ClockStopping; });
+	if (!ClockRunning) {
+		return;
+	}
+	ClockRunning = false;
+	ClockStopping = true;
+	ClockCond.notify_all();
+	lock.unlock();
+	Clock.join();
+	lock.lock();
+	ClockStopping = false;
+	ClockCond.notify_all();
+}
+
+BlinktPlugin::ClockGuard::~ClockGuard() {
+	// Join the clock before the Clock thread object is destroyed when the
+	// library is unloaded, in case the last plugin instance never was
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	stopClock(lock);
+}
+
+void BlinktPlugin::runClock() {
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	auto next = std::chrono::steady_clock::now();
+	while (ClockRunning) {
+		if (!Transitioning && !Dithering) {
+			ClockCond.wait(lock);
+			next = std::chrono::steady_clock::now();
+			continue;
+		}
+
+		Transitioning = blinkt_transition_step(millis());
+		Dithering = blinkt_dither_step();
 		blinkt_refresh();
+
+		// Wait for the next frame, keeping a steady cadence unless we
+		// have fallen behind. In that case still wait a full frame
+		// period, so that other threads get the lock between frames.
+		auto period = std::chrono::microseconds(1000000 / FrameRate);
+		next += period;
+		auto now = std::chrono::steady_clock::now();
+		if (next < now) {
+			next = now + period;
+		}
+		ClockCond.wait_until(lock, next, [] { return !ClockRunning; });
 	}
 }
 
@@ -48,32 +155,131 @@ BlinktPlugin::~BlinktPlugin() {
 // Mostly these just map through to wiringPi or blinkt_functions
 
 void BlinktPlugin::setLED(int64_t num, int64_t red, int64_t green, int64_t blue, double intensity) {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	blinkt_set_led(num, red, green, blue, intensity);
 }
 
 void BlinktPlugin::setAll(int64_t red, int64_t green, int64_t blue, double intensity) {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	blinkt_set_all(red, green, blue, intensity);
 }
 
 void BlinktPlugin::setIntensity(int64_t num, double intensity) {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	blinkt_set_intensity(num, intensity);
 }
 
 void BlinktPlugin::setIntensityAll(double intensity) {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	blinkt_set_intensity(intensity);
 }
 
+void BlinktPlugin::setHSV(int64_t num, double hue, double sat, double val, double intensity) {
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	blinkt_set_led_hsv(num, toHueUnits(hue), toByte(sat), toByte(val), intensity);
+}
+
+void BlinktPlugin::setAllHSV(double hue, double sat, double val, double intensity) {
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	blinkt_set_all_hsv(toHueUnits(hue), toByte(sat), toByte(val), intensity);
+}
+
+void BlinktPlugin::fillHueGradient(int64_t first, int64_t num, double startHue, double step, double intensity) {
+	if (first < 0 || num <= 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	blinkt_fill_hue_gradient(first, num, toHueUnits(startHue), toHueUnits(step), intensity);
+}
+
+void BlinktPlugin::fillRGBGradient(int64_t first, int64_t num,
+		int64_t red1, int64_t green1, int64_t blue1,
+		int64_t red2, int64_t green2, int64_t blue2,
+		double intensity) {
+	if (first < 0 || num <= 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	blinkt_fill_rgb_gradient(first, num, red1, green1, blue1, red2, green2, blue2, intensity);
+}
+
+// The clock is started before the LED state is changed, since starting it
+// may have to wait for a previous clock to stop, and the clock can't run until
+// the lock is released anyway.
+
+void BlinktPlugin::transitionLED(int64_t num, int64_t red, int64_t green, int64_t blue, double intensity,
+		int64_t durationMs, int64_t easing) {
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	startClock(lock);
+	blinkt_transition_led(num, red, green, blue, intensity,
+		toDuration(durationMs), easing, millis());
+	Transitioning = true;
+}
+
+void BlinktPlugin::transitionRange(int64_t first, int64_t num, int64_t red, int64_t green, int64_t blue,
+		double intensity, int64_t durationMs, int64_t easing) {
+	if (first < 0 || num <= 0) {
+		return;
+	}
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	startClock(lock);
+	blinkt_transition_range(first, num, red, green, blue, intensity,
+		toDuration(durationMs), easing, millis());
+	Transitioning = true;
+}
+
+void BlinktPlugin::transitionAll(int64_t red, int64_t green, int64_t blue, double intensity,
+		int64_t durationMs, int64_t easing) {
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	startClock(lock);
+	blinkt_transition_all(red, green, blue, intensity,
+		toDuration(durationMs), easing, millis());
+	Transitioning = true;
+}
+
+bool BlinktPlugin::isTransitioning() {
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	return blinkt_is_transitioning();
+}
+
+int64_t BlinktPlugin::setFrameRate(int64_t fps) {
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	unsigned rval = FrameRate;
+	FrameRate = fps < 1 ? 1 : fps > 1000 ? 1000 : fps;
+	return rval;
+}
+
+void BlinktPlugin::setLED16(int64_t num, int64_t red, int64_t green, int64_t blue) {
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	if (DitherEnabled) {
+		startClock(lock);
+		Dithering = true;
+	}
+	blinkt_set_led16(num, toLevel(red), toLevel(green), toLevel(blue));
+}
+
+void BlinktPlugin::setAll16(int64_t red, int64_t green, int64_t blue) {
+	std::unique_lock<std::mutex> lock(BLINKT_MUTEX);
+	if (DitherEnabled) {
+		startClock(lock);
+		Dithering = true;
+	}
+	blinkt_set_all16(toLevel(red), toLevel(green), toLevel(blue));
+}
+
+bool BlinktPlugin::enableDither(bool enable) {
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	DitherEnabled = enable;
+	return blinkt_enable_dither(enable);
+}
+
 void BlinktPlugin::refresh() {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	blinkt_refresh();
 }
 
 void BlinktPlugin::reset() {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	blinkt_reset();
 }
 
@@ -82,12 +288,12 @@ void BlinktPlugin::delay(int64_t millis) {
 }
 
 bool BlinktPlugin::enableDebug(bool enable) {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	return blinkt_enable_debug(enable);
 }
 
 bool BlinktPlugin::enableResetOnUnload(bool enable) {
-	std::lock_guard<std::mutex> lock(Mutex);
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
 	bool rval = ResetOnUnload;
 	ResetOnUnload = enable;
 	return rval;
@@ -22,6 +22,7 @@
 #include <epl_plugin.hpp>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 
 using namespace com::apama::epl;
 
@@ -55,17 +56,20 @@ using namespace com::apama::epl;
  * as though they were 1.0, i.e. maximum intensity.
  *
  * The plugin keeps an internal colour/intensity state for each LED that is
- * only transferred to the real LEDs when the refresh() action is called. This
- * is the only way to change the state of the physical LEDs. The effects of
- * any number of preceding set*() and reset() actions will become visible only
- * when refresh() is called.
+ * transferred to the real LEDs when the refresh() action is called. The
+ * effects of any number of preceding set*() and reset() actions will become
+ * visible when refresh() is called. The exception is while transitions or
+ * dithering are in progress, when the plugin's output clock refreshes all the
+ * LEDs at the current frame rate. Changes made to any LED during that time
+ * may become visible at the next frame, without calling refresh().
  *
  * For more information on the Blinkt! hardware and other language APIs see:
  * https://github.com/pimoroni/blinkt (Blinkt! GitHub project)
  * https://cdn-shop.adafruit.com/product-files/2343/APA102C.pdf (APA102 datasheet)
  *
  * The plugin is thread-safe and can be accessed from multiple EPL contexts in
- * parallel.
+ * parallel. All access to the Blinkt is serialised using BLINKT_MUTEX, which
+ * is shared with the BlinktTransport connectivity transport.
  *
  * Before using the plugin to control the Blinkt, the appropriate GPIO pins
  * for the Blinkt data and clock lines must be configured as outputs. This
@@ -95,6 +99,30 @@ public:
 			&BlinktPlugin::setIntensity>("setIntensity");
 		md.registerMethod<decltype(&BlinktPlugin::setIntensityAll),
 			&BlinktPlugin::setIntensityAll>("setIntensityAll");
+		md.registerMethod<decltype(&BlinktPlugin::setHSV),
+			&BlinktPlugin::setHSV>("setHSV");
+		md.registerMethod<decltype(&BlinktPlugin::setAllHSV),
+			&BlinktPlugin::setAllHSV>("setAllHSV");
+		md.registerMethod<decltype(&BlinktPlugin::fillHueGradient),
+			&BlinktPlugin::fillHueGradient>("fillHueGradient");
+		md.registerMethod<decltype(&BlinktPlugin::fillRGBGradient),
+			&BlinktPlugin::fillRGBGradient>("fillRGBGradient");
+		md.registerMethod<decltype(&BlinktPlugin::transitionLED),
+			&BlinktPlugin::transitionLED>("transitionLED");
+		md.registerMethod<decltype(&BlinktPlugin::transitionRange),
+			&BlinktPlugin::transitionRange>("transitionRange");
+		md.registerMethod<decltype(&BlinktPlugin::transitionAll),
+			&BlinktPlugin::transitionAll>("transitionAll");
+		md.registerMethod<decltype(&BlinktPlugin::isTransitioning),
+			&BlinktPlugin::isTransitioning>("isTransitioning");
+		md.registerMethod<decltype(&BlinktPlugin::setFrameRate),
+			&BlinktPlugin::setFrameRate>("setFrameRate");
+		md.registerMethod<decltype(&BlinktPlugin::setLED16),
+			&BlinktPlugin::setLED16>("setLED16");
+		md.registerMethod<decltype(&BlinktPlugin::setAll16),
+			&BlinktPlugin::setAll16>("setAll16");
+		md.registerMethod<decltype(&BlinktPlugin::enableDither),
+			&BlinktPlugin::enableDither>("enableDither");
 		md.registerMethod<decltype(&BlinktPlugin::refresh),
 			&BlinktPlugin::refresh>("refresh");
 		md.registerMethod<decltype(&BlinktPlugin::reset),
@@ -158,6 +186,178 @@ public:
 	 */
 	void setIntensityAll(double intensity);
 
+	/**
+	 * Set the colour of a Blinkt LED from an HSV (hue, saturation,
+	 * value) colour value, and its intensity. The conversion to RGB is
+	 * done in fixed point by blinkt_functions. This function just
+	 * changes internal plugin state. Use the refresh() function to
+	 * actually update the Blinkt LEDs.
+	 *
+	 * @param num The LED number to set, starting from zero.
+	 * @param hue The hue in degrees, wrapped into the range 0-360.
+	 * @param sat The saturation, from 0.0 to 1.0.
+	 * @param val The value, from 0.0 to 1.0.
+	 * @param intensity The global intensity of the LED.
+	 */
+	void setHSV(int64_t num, double hue, double sat, double val, double intensity);
+
+	/**
+	 * Set the colour of all Blinkt LEDs from an HSV colour value, and
+	 * their intensity. This function just changes internal plugin state.
+	 * Use the refresh() function to actually update the Blinkt LEDs.
+	 *
+	 * @param hue The hue in degrees, wrapped into the range 0-360.
+	 * @param sat The saturation, from 0.0 to 1.0.
+	 * @param val The value, from 0.0 to 1.0.
+	 * @param intensity The global intensity of the LEDs.
+	 */
+	void setAllHSV(double hue, double sat, double val, double intensity);
+
+	/**
+	 * Fill a range of Blinkt LEDs with fully saturated colours whose hue
+	 * changes by a fixed step from each LED to the next. This function
+	 * just changes internal plugin state. Use the refresh() function to
+	 * actually update the Blinkt LEDs.
+	 *
+	 * @param first The leftmost LED to set, starting from zero.
+	 * @param num The number of LEDs to set.
+	 * @param startHue The hue of the first LED in degrees.
+	 * @param step The change in hue between adjacent LEDs in degrees.
+	 * @param intensity The global intensity of the LEDs.
+	 */
+	void fillHueGradient(int64_t first, int64_t num, double startHue, double step, double intensity);
+
+	/**
+	 * Fill a range of Blinkt LEDs with a linear RGB gradient from a start
+	 * colour on the first LED to an end colour on the last LED. This
+	 * function just changes internal plugin state. Use the refresh()
+	 * function to actually update the Blinkt LEDs.
+	 *
+	 * @param first The leftmost LED to set, starting from zero.
+	 * @param num The number of LEDs in the gradient.
+	 * @param red1 The red component of the start colour.
+	 * @param green1 The green component of the start colour.
+	 * @param blue1 The blue component of the start colour.
+	 * @param red2 The red component of the end colour.
+	 * @param green2 The green component of the end colour.
+	 * @param blue2 The blue component of the end colour.
+	 * @param intensity The global intensity of the LEDs.
+	 */
+	void fillRGBGradient(int64_t first, int64_t num,
+			int64_t red1, int64_t green1, int64_t blue1,
+			int64_t red2, int64_t green2, int64_t blue2,
+			double intensity);
+
+	/**
+	 * Start a timed transition of a Blinkt LED from its current colour
+	 * and intensity to a new target. The transition is run by the
+	 * plugin's output clock, which refreshes the LEDs at the current
+	 * frame rate until all transitions are complete, so there is no need
+	 * to call refresh(). A new transition on an LED that is already
+	 * transitioning starts from its current interpolated value. Any
+	 * set*(), fill*() or reset() call affecting the LED cancels its
+	 * transition.
+	 *
+	 * @param num The LED number to set, starting from zero.
+	 * @param red The red component of the target RGB colour value.
+	 * @param green The green component of the target RGB colour value.
+	 * @param blue The blue component of the target RGB colour value.
+	 * @param intensity The target global intensity of the LED, or less
+	 * than zero to leave it unchanged.
+	 * @param durationMs The duration of the transition in milliseconds.
+	 * @param easing The easing curve: 0 linear, 1 ease-in, 2 ease-out,
+	 * 3 ease-in-out.
+	 */
+	void transitionLED(int64_t num, int64_t red, int64_t green, int64_t blue, double intensity,
+			int64_t durationMs, int64_t easing);
+
+	/**
+	 * Start a timed transition of a contiguous range of Blinkt LEDs to a
+	 * new colour and intensity. See transitionLED() for details.
+	 *
+	 * @param first The leftmost LED to set, starting from zero.
+	 * @param num The number of LEDs to set.
+	 * @param red The red component of the target RGB colour value.
+	 * @param green The green component of the target RGB colour value.
+	 * @param blue The blue component of the target RGB colour value.
+	 * @param intensity The target global intensity of the LEDs.
+	 * @param durationMs The duration of the transition in milliseconds.
+	 * @param easing The easing curve.
+	 */
+	void transitionRange(int64_t first, int64_t num, int64_t red, int64_t green, int64_t blue,
+			double intensity, int64_t durationMs, int64_t easing);
+
+	/**
+	 * Start a timed transition of all Blinkt LEDs to a new colour and
+	 * intensity. See transitionLED() for details.
+	 *
+	 * @param red The red component of the target RGB colour value.
+	 * @param green The green component of the target RGB colour value.
+	 * @param blue The blue component of the target RGB colour value.
+	 * @param intensity The target global intensity of the LEDs.
+	 * @param durationMs The duration of the transition in milliseconds.
+	 * @param easing The easing curve.
+	 */
+	void transitionAll(int64_t red, int64_t green, int64_t blue, double intensity,
+			int64_t durationMs, int64_t easing);
+
+	/**
+	 * Check whether any transitions are still in progress.
+	 *
+	 * @return True if any transitions are in progress.
+	 */
+	bool isTransitioning();
+
+	/**
+	 * Set the rate at which the output clock refreshes the LEDs while
+	 * transitions or dithering are in progress. The default is 100
+	 * frames per second and the rate is limited to the range 1-1000.
+	 * The clock always waits at least one frame period after refreshing
+	 * the LEDs, so if a refresh takes longer than a frame period the
+	 * effective rate drops to about 1 / (refresh time + frame period).
+	 *
+	 * @param fps The new frame rate in frames per second.
+	 * @return The previous frame rate.
+	 */
+	int64_t setFrameRate(int64_t fps);
+
+	/**
+	 * Set a Blinkt LED to a 16-bit per channel linear output level,
+	 * where 65535 is the full colour value at maximum intensity. The
+	 * intensity and colour values sent to the LED are chosen
+	 * automatically. If dithering is enabled the LED is driven by the
+	 * output clock, which approximates the target at higher colour depth
+	 * over successive frames, otherwise the nearest single value is set
+	 * and refresh() must be called as usual.
+	 *
+	 * @param num The LED number to set, starting from zero.
+	 * @param red The red output level (0-65535).
+	 * @param green The green output level (0-65535).
+	 * @param blue The blue output level (0-65535).
+	 */
+	void setLED16(int64_t num, int64_t red, int64_t green, int64_t blue);
+
+	/**
+	 * Set all Blinkt LEDs to a 16-bit per channel linear output level.
+	 * See setLED16() for details.
+	 *
+	 * @param red The red output level (0-65535).
+	 * @param green The green output level (0-65535).
+	 * @param blue The blue output level (0-65535).
+	 */
+	void setAll16(int64_t red, int64_t green, int64_t blue);
+
+	/**
+	 * Enable or disable temporal dithering of LEDs set by setLED16() and
+	 * by transitions. Dithering is run by the output clock, so it should
+	 * be combined with a frame rate well above 100 fps, see
+	 * setFrameRate().
+	 *
+	 * @param enable True to enable dithering, false to disable it.
+	 * @return The previous value of the dithering flag.
+	 */
+	bool enableDither(bool enable);
+
 	/**
 	 * Update all the Blinkt LEDs to match the internal colour and
 	 * intensity state of the plugin, making the effects of all previous
@@ -226,8 +426,34 @@ private:
 	// Reset-on-unload flag
 	static bool ResetOnUnload;
 
-	// Global lock for all plugin functions
-	static std::mutex Mutex;
+	// Start the output clock if it isn't already running and wake it
+	// up, first waiting for any clock that is being stopped to finish.
+	// The caller must hold the lock on BLINKT_MUTEX.
+	static void startClock(std::unique_lock<std::mutex> &lock);
+
+	// Stop the output clock, temporarily releasing the lock held by the
+	// caller while waiting for the clock thread to finish.
+	static void stopClock(std::unique_lock<std::mutex> &lock);
+
+	// Output clock thread main loop
+	static void runClock();
+
+	// Output clock thread and state, guarded by BLINKT_MUTEX
+	static std::thread Clock;
+	static std::condition_variable ClockCond;
+	static bool ClockRunning;
+	static bool ClockStopping;
+	static bool Transitioning;
+	static bool Dithering;
+	static bool DitherEnabled;
+	static unsigned FrameRate;
+
+	// Stops the output clock when the library is unloaded. Defined after
+	// Clock so that it is destroyed first.
+	struct ClockGuard {
+		~ClockGuard();
+	};
+	static ClockGuard Guard;
 };
 
 // Make the plugin available to EPL
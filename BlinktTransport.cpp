@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016-2020 Scott Mitchell.
+ * All rights reserved.
+ *
+ * Licenced under the BSD 3-Clause licence (the "Licence"); you may not use
+ * this file except in compliance with the Licence. You may obtain a copy of
+ * the Licence from the LICENCE file in the top level of this software
+ * distribution or from:
+ *
+ *	 https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// See BlinktTransport.h for details of the public API of this transport.
+
+#include "BlinktTransport.h"
+#include "blinkt_functions.h"
+#include "blinkt_lock.h"
+#include <wiringPi.h>
+
+
+
+BlinktTransport::BlinktTransport(const TransportConstructorParameters &params):
+	AbstractTransport(params), running(false)
+{
+	MapExtractor config(params.getConfig(), "BlinktTransport configuration");
+	setupGPIO = config.get<bool>("setupGPIO", false);
+	resetOnShutdown = config.get<bool>("resetOnShutdown", true);
+	config.checkEmpty();
+}
+
+BlinktTransport::~BlinktTransport() {
+	// Make sure the worker has gone even if shutdown() was never called
+	shutdown();
+}
+
+void BlinktTransport::start() {
+	if (setupGPIO) {
+		(void) wiringPiSetupSys();
+	}
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+	running = true;
+	worker = std::thread(&BlinktTransport::run, this);
+	logger.info("BlinktTransport started");
+}
+
+void BlinktTransport::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (!running) {
+			return;
+		}
+		running = false;
+	}
+	queueCond.notify_one();
+	worker.join();
+
+	if (resetOnShutdown) {
+		std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+		blinkt_reset();
+		blinkt_refresh();
+	}
+	logger.info("BlinktTransport stopped");
+}
+
+void BlinktTransport::sendBatchTowardsTransport(Message *start, Message *end) {
+	// Decode outside the queue lock so the worker is never held up
+	std::vector<Update> updates;
+	updates.reserve(end - start);
+	for (Message *m = start; m != end; ++m) {
+		Update update;
+		if (decode(*m, update)) {
+			updates.push_back(std::move(update));
+		}
+	}
+	if (updates.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		for (auto &update: updates) {
+			pending.push_back(std::move(update));
+		}
+	}
+	queueCond.notify_one();
+}
+
+bool BlinktTransport::decode(const Message &message, Update &update) {
+	const data_t &payload = message.getPayload();
+	if (payload.type_tag() != SAG_DATA_MAP) {
+		logger.warn("Ignoring message with non-map payload");
+		return false;
+	}
+	const map_t &fields = get<map_t>(payload);
+
+	update.first = 0;
+	auto it = fields.find(data_t("first"));
+	if (it != fields.end()) {
+		if (it->second.type_tag() != SAG_DATA_INTEGER) {
+			logger.warn("Ignoring update with non-integer first LED");
+			return false;
+		}
+		int64_t first = get<int64_t>(it->second);
+		if (first < 0 || first >= BLINKT_NUM_LEDS) {
+			logger.warn("Ignoring update with invalid first LED %lld", (long long)first);
+			return false;
+		}
+		update.first = (unsigned)first;
+	}
+
+	// Anything past the last LED is silently dropped
+	unsigned maxLEDs = BLINKT_NUM_LEDS - update.first;
+
+	it = fields.find(data_t("colours"));
+	if (it == fields.end()) {
+		logger.warn("Ignoring update with no colours");
+		return false;
+	}
+	if (it->second.type_tag() != SAG_DATA_LIST) {
+		logger.warn("Ignoring update with non-list colours");
+		return false;
+	}
+	for (const data_t &colour: get<list_t>(it->second)) {
+		if (update.colours.size() == maxLEDs) {
+			break;
+		}
+		if (colour.type_tag() != SAG_DATA_INTEGER) {
+			logger.warn("Ignoring update with non-integer colour");
+			return false;
+		}
+		update.colours.push_back((uint32_t)get<int64_t>(colour));
+	}
+
+	it = fields.find(data_t("intensities"));
+	if (it != fields.end()) {
+		if (it->second.type_tag() != SAG_DATA_LIST) {
+			logger.warn("Ignoring update with non-list intensities");
+			return false;
+		}
+		for (const data_t &intensity: get<list_t>(it->second)) {
+			if (update.intensities.size() == maxLEDs) {
+				break;
+			}
+			// Adapters such as JSON may deliver whole numbers as integers
+			if (intensity.type_tag() == SAG_DATA_DOUBLE) {
+				update.intensities.push_back((float)get<double>(intensity));
+			} else if (intensity.type_tag() == SAG_DATA_INTEGER) {
+				update.intensities.push_back((float)get<int64_t>(intensity));
+			} else {
+				logger.warn("Ignoring update with non-numeric intensity");
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void BlinktTransport::apply(const std::vector<Update> &updates) {
+	std::lock_guard<std::mutex> lock(BLINKT_MUTEX);
+	for (const Update &update: updates) {
+		size_t numIntensities = update.intensities.size();
+		for (size_t i = 0; i < update.colours.size(); i++) {
+			uint32_t c = update.colours[i];
+			float intensity = -1.0;
+			if (numIntensities == 1) {
+				intensity = update.intensities[0];
+			} else if (i < numIntensities) {
+				intensity = update.intensities[i];
+			}
+			blinkt_set_led(update.first + i, c >> 16, c >> 8, c, intensity);
+		}
+	}
+	blinkt_refresh();
+}
+
+void BlinktTransport::run() {
+	std::vector<Update> batch;
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while (true) {
+		queueCond.wait(lock, [this] { return !running || !pending.empty(); });
+		if (pending.empty()) {
+			// Only reached once running is false and the queue has drained
+			break;
+		}
+
+		// Take everything queued so far and apply it as one batch
+		batch.clear();
+		batch.swap(pending);
+		lock.unlock();
+		apply(batch);
+		lock.lock();
+	}
+}
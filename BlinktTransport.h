@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2016-2020 Scott Mitchell.
+ * All rights reserved.
+ *
+ * Licenced under the BSD 3-Clause licence (the "Licence"); you may not use
+ * this file except in compliance with the Licence. You may obtain a copy of
+ * the Licence from the LICENCE file in the top level of this software
+ * distribution or from:
+ *
+ *	 https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _BLINKT_TRANSPORT_H
+#define _BLINKT_TRANSPORT_H
+
+#include <sag_connectivity_plugins.hpp>
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+using namespace com::softwareag::connectivity;
+
+
+/**
+ * Connectivity transport to control the Pimoroni Blinkt APA102 LED board
+ * directly from a connectivity chain, without executing any EPL for each LED
+ * update. The transport is built into the same shared library as the
+ * BlinktPlugin and shares its LED state and BLINKT_MUTEX lock, so the plugin
+ * and the transport can safely be used together in the same correlator.
+ *
+ * Messages sent towards the transport are expected to have a map payload,
+ * typically produced by the apama.eventMap host plugin from an
+ * rpi.blinkt.BlinktFrame or rpi.blinkt.BlinktRegion event. The following
+ * payload keys are used:
+ *
+ * - first: The leftmost LED to update (optional, defaults to zero).
+ * - colours: A list of packed 0xRRGGBB colour values, one per LED starting
+ *   from the first LED. Values beyond the last LED are ignored.
+ * - intensities: A list of intensity values (optional). If empty or missing
+ *   the intensity of the LEDs is left unchanged, if it has a single element
+ *   that intensity is applied to all the updated LEDs, otherwise each
+ *   element applies to the corresponding LED. Integer values are accepted
+ *   as well as floats.
+ *
+ * A message with a missing or wrongly typed field is logged and ignored,
+ * without affecting the other messages in the same batch.
+ *
+ * Messages are decoded on the host thread and queued. A separate worker
+ * thread applies all the queued updates in a single batch under BLINKT_MUTEX
+ * and then refreshes the LEDs once, so at high message rates many
+ * updates are coalesced into each refresh.
+ *
+ * The transport accepts the following configuration options:
+ *
+ * - setupGPIO: If true, initialise the wiringPi library when the transport
+ *   starts (default false). Only use this if the BlinktSetup monitor from
+ *   BlinktHelper.mon will not be injected into the correlator, and the GPIO
+ *   pins have already been exported by the blinkt_setup script.
+ * - resetOnShutdown: If true, reset and refresh the LEDs when the transport
+ *   is shut down (default true).
+ */
+class BlinktTransport: public AbstractTransport {
+
+public:
+
+	// Constructor called by the correlator when the chain is created
+	BlinktTransport(const TransportConstructorParameters &params);
+
+	// Default destructor
+	virtual ~BlinktTransport();
+
+	/**
+	 * Start the worker thread that applies updates to the LEDs.
+	 */
+	virtual void start() override;
+
+	/**
+	 * Stop the worker thread, applying any updates that are still
+	 * queued, and optionally reset the LEDs.
+	 */
+	virtual void shutdown() override;
+
+	/**
+	 * Decode a batch of messages from the host and queue the resulting
+	 * LED updates for the worker thread.
+	 *
+	 * @param start Pointer to the first message in the batch.
+	 * @param end Pointer to one past the last message in the batch.
+	 */
+	virtual void sendBatchTowardsTransport(Message *start, Message *end) override;
+
+
+private:
+	// A single decoded frame or region update
+	struct Update {
+		unsigned first;
+		std::vector<uint32_t> colours;
+		std::vector<float> intensities;
+	};
+
+	// Decode a message payload, returning false if it is invalid
+	bool decode(const Message &message, Update &update);
+
+	// Apply a batch of updates to the LEDs and refresh them
+	void apply(const std::vector<Update> &updates);
+
+	// Worker thread main loop
+	void run();
+
+	// Configuration options
+	bool setupGPIO;
+	bool resetOnShutdown;
+
+	// Updates waiting to be applied, guarded by queueMutex
+	std::vector<Update> pending;
+	std::mutex queueMutex;
+	std::condition_variable queueCond;
+	bool running;
+
+	// Worker thread
+	std::thread worker;
+};
+
+// Make the transport available to connectivity chains
+SAG_DECLARE_CONNECTIVITY_TRANSPORT_CLASS(BlinktTransport)
+
+#endif // _BLINKT_TRANSPORT_H
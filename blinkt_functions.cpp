@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <algorithm>
 #include <wiringPi.h>
 
 static const unsigned BLINKT_BYTES_PER_LED = 4;
@@ -36,6 +37,38 @@ static const uint8_t BLINKT_INTENSITY_MASK = (uint8_t)~BLINKT_INTENSITY_MAX;
  */
 static uint8_t BLINKT_BUFFER[BLINKT_BUFFER_LENGTH];
 
+/*
+ * State of a transition on a single LED. All values are 8.8 fixed point,
+ * in IBGR order to match the buffer.
+ */
+struct blinkt_transition {
+	bool active;
+	bool valid;		// current still matches the LED, even if complete
+	uint8_t easing;
+	uint32_t start;
+	uint32_t duration;
+	uint16_t from[BLINKT_BYTES_PER_LED];
+	uint16_t to[BLINKT_BYTES_PER_LED];
+	uint16_t current[BLINKT_BYTES_PER_LED];
+};
+
+static blinkt_transition BLINKT_TRANSITIONS[BLINKT_NUM_LEDS];
+
+/*
+ * Dithering state of a single LED. The target is 16-bit linear output in
+ * BGR order, and the error is the 8.8 fixed point colour value carried over
+ * from previous frames.
+ */
+struct blinkt_dither {
+	bool active;
+	uint16_t target[3];
+	uint16_t error[3];
+};
+
+static blinkt_dither BLINKT_DITHERS[BLINKT_NUM_LEDS];
+
+static bool BLINKT_DITHER = false;
+
 static bool BLINKT_DEBUG = false;
 
 /*
@@ -86,6 +119,177 @@ void blinkt_dump_buffer() {
 	fflush(stdout);
 }
 
+/*
+ * One channel of the HSV->RGB conversion, using the branch-free formulation
+ * f(n) = V - V*S*clamp(min(k, 4-k), 0, 1) where k = (n + H/60) mod 6 and n is
+ * 5, 3 or 1 for red, green or blue. Everything is done in 16.16 fixed point:
+ * hue6 is the hue scaled to the range 0-6 and vs is the product of the value
+ * and saturation. The final division by 255*256 is done as a multiply by 257
+ * and a shift, which just fits in 32 bits.
+ */
+static inline uint8_t blinkt_hsv_channel(uint32_t hue6, uint32_t n, uint32_t vs, uint8_t val) {
+	const int32_t one = 1 << 16;
+	int32_t k = (int32_t)(hue6 + n * one);
+	k -= (k >= 6 * one) ? 6 * one : 0;
+	int32_t m = std::min(k, 4 * one - k);
+	m = std::max(0, std::min(m, one));
+	return val - (uint8_t)((vs * ((uint32_t)m >> 8) * 257 + (1 << 23)) >> 24);
+}
+
+/*
+ * Cancel any transitions or dithering on a range of LEDs that is already
+ * known to be valid, so that they don't overwrite a value that has been set
+ * directly.
+ */
+static void blinkt_cancel_updates(unsigned first, unsigned num) {
+	for (unsigned n = first; n < first + num; n++) {
+		BLINKT_TRANSITIONS[n].active = false;
+		BLINKT_TRANSITIONS[n].valid = false;
+		BLINKT_DITHERS[n].active = false;
+	}
+}
+
+/*
+ * The global intensity used for a 16-bit target, which is the lowest level
+ * that can still reach the brightest channel, leaving the most colour
+ * resolution for the 8-bit channel values.
+ */
+static uint32_t blinkt_dither_intensity(const blinkt_dither &d) {
+	uint32_t max = std::max(d.target[0], std::max(d.target[1], d.target[2]));
+	return (max * BLINKT_INTENSITY_MAX + 0xfffe) / 0xffff;
+}
+
+/*
+ * The 8.8 fixed point colour value of one channel of a 16-bit target at a
+ * given non-zero global intensity.
+ */
+static uint32_t blinkt_dither_value(const blinkt_dither &d, unsigned c, uint32_t intensity) {
+	const uint64_t scale = (uint64_t)BLINKT_INTENSITY_MAX * 255 * 256;
+	return (uint32_t)((d.target[c] * scale) / (intensity * 0xffff));
+}
+
+/*
+ * Check whether a 16-bit target can be shown exactly in a single frame, in
+ * which case there is no quantisation error to diffuse.
+ */
+static bool blinkt_dither_exact(const blinkt_dither &d) {
+	uint32_t intensity = blinkt_dither_intensity(d);
+	if (intensity == 0) {
+		return true;
+	}
+	for (unsigned c = 0; c < 3; c++) {
+		if (blinkt_dither_value(d, c, intensity) & 0xff) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Write the next frame for a 16-bit target to an LED in the buffer. When
+ * diffusing, the fractional part of each colour value is carried over to the
+ * next frame so that the average output over several frames approximates the
+ * target; otherwise it is just rounded.
+ */
+static void blinkt_dither_frame(blinkt_dither &d, uint8_t* p, bool diffuse) {
+	uint32_t intensity = blinkt_dither_intensity(d);
+	if (intensity == 0) {
+		p[0] = p[1] = p[2] = p[3] = 0;
+		d.error[0] = d.error[1] = d.error[2] = 0;
+		return;
+	}
+
+	for (unsigned c = 0; c < 3; c++) {
+		uint32_t v = blinkt_dither_value(d, c, intensity);
+		v += diffuse ? d.error[c] : 0x80;
+		uint32_t out = std::min(v >> 8, 255u);
+		d.error[c] = diffuse ? std::min(v - (out << 8), 255u) : 0;
+		p[c + 1] = (uint8_t)out;
+	}
+	p[0] = (uint8_t)intensity;
+}
+
+/*
+ * Set the dithering target of an LED that is already known to be valid. The
+ * LED is only left to the dithering stage if the target can't be shown
+ * exactly, so that zero or exact targets don't keep the output clock busy.
+ */
+static void blinkt_dither_target(unsigned num, uint16_t red, uint16_t green, uint16_t blue) {
+	blinkt_dither &d = BLINKT_DITHERS[num];
+	d.target[0] = blue;
+	d.target[1] = green;
+	d.target[2] = red;
+	d.active = BLINKT_DITHER && !blinkt_dither_exact(d);
+	if (!d.active) {
+		blinkt_dither_frame(d, BLINKT_BUFFER + (num * BLINKT_BYTES_PER_LED), false);
+	}
+}
+
+/*
+ * Apply an easing curve to a transition position, both in 16.16 fixed point.
+ */
+static uint32_t blinkt_ease(uint32_t t, uint8_t easing) {
+	const uint64_t one = 1 << 16;
+	switch (easing) {
+	case BLINKT_EASE_IN:
+		return (uint32_t)((t * (uint64_t)t) >> 16);
+	case BLINKT_EASE_OUT:
+		return (uint32_t)((t * (2 * one - t)) >> 16);
+	case BLINKT_EASE_IN_OUT:
+		return (uint32_t)((((t * (uint64_t)t) >> 16) * (3 * one - 2 * t)) >> 16);
+	default:
+		return t;
+	}
+}
+
+/*
+ * Bring the current value of a transition up to date, returning false if the
+ * transition is complete. Time arithmetic is unsigned so that it still works
+ * when millis() wraps around.
+ */
+static bool blinkt_transition_update(blinkt_transition &tr, uint32_t now) {
+	uint32_t elapsed = now - tr.start;
+	if (elapsed >= tr.duration) {
+		for (unsigned c = 0; c < BLINKT_BYTES_PER_LED; c++) {
+			tr.current[c] = tr.to[c];
+		}
+		return false;
+	}
+
+	int32_t e = (int32_t)blinkt_ease((uint32_t)(((uint64_t)elapsed << 16) / tr.duration), tr.easing);
+	for (unsigned c = 0; c < BLINKT_BYTES_PER_LED; c++) {
+		int32_t delta = (int32_t)tr.to[c] - (int32_t)tr.from[c];
+		tr.current[c] = (uint16_t)(tr.from[c] + (int32_t)(((int64_t)delta * e) >> 16));
+	}
+	return true;
+}
+
+/*
+ * Set the intensity of a range of LEDs that is already known to be valid,
+ * ignoring negative intensities.
+ */
+static void blinkt_set_range_intensity(unsigned first, unsigned num, float intensity) {
+	if (intensity < 0.0) {
+		return;
+	}
+	uint8_t i = (uint8_t)(BLINKT_INTENSITY_MAX * (intensity > 1.0 ? 1.0 : intensity));
+	uint8_t* p = BLINKT_BUFFER + (first * BLINKT_BYTES_PER_LED);
+	for (unsigned n = 0; n < num; n++, p += BLINKT_BYTES_PER_LED) {
+		*p = i;
+	}
+}
+
+/*
+ * Clip a range of LEDs to the end of the Blinkt, returning the number of
+ * LEDs in the range that actually exist.
+ */
+static unsigned blinkt_clip_range(unsigned first, unsigned num) {
+	if (first >= BLINKT_NUM_LEDS) {
+		return 0;
+	}
+	return std::min(num, BLINKT_NUM_LEDS - first);
+}
+
 
 // Public API functions
 
@@ -109,12 +313,14 @@ void blinkt_reset() {
 	for (int i = 0; i < BLINKT_BUFFER_LENGTH; i++) {
 		BLINKT_BUFFER[i] = (uint8_t)0;
 	}
+	blinkt_cancel_updates(0, BLINKT_NUM_LEDS);
 }
 
 void blinkt_set_led(unsigned num, uint8_t red, uint8_t green, uint8_t blue, float intensity) {
-	if (num > BLINKT_NUM_LEDS) {
+	if (num >= BLINKT_NUM_LEDS) {
 		return;
 	}
+	blinkt_cancel_updates(num, 1);
 
 	uint8_t* p = BLINKT_BUFFER + (num * BLINKT_BYTES_PER_LED);
 
@@ -133,9 +339,10 @@ void blinkt_set_all(uint8_t red, uint8_t green, uint8_t blue, float intensity) {
 }
 
 void blinkt_set_intensity(unsigned num, float intensity) {
-	if (num > BLINKT_NUM_LEDS) {
+	if (num >= BLINKT_NUM_LEDS) {
 		return;
 	}
+	blinkt_cancel_updates(num, 1);
 	BLINKT_BUFFER[num * BLINKT_BYTES_PER_LED] = (uint8_t)(BLINKT_INTENSITY_MAX * (intensity > 1.0 ? 1.0 : intensity));
 }
 
@@ -145,6 +352,245 @@ void blinkt_set_intensity(float intensity) {
 	}
 }
 
+void blinkt_hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val, uint8_t &red, uint8_t &green, uint8_t &blue) {
+	uint32_t hue6 = hue * 6u;
+	uint32_t vs = val * sat;
+	red = blinkt_hsv_channel(hue6, 5, vs, val);
+	green = blinkt_hsv_channel(hue6, 3, vs, val);
+	blue = blinkt_hsv_channel(hue6, 1, vs, val);
+}
+
+void blinkt_set_led_hsv(unsigned num, uint16_t hue, uint8_t sat, uint8_t val, float intensity) {
+	uint8_t red, green, blue;
+	blinkt_hsv_to_rgb(hue, sat, val, red, green, blue);
+	blinkt_set_led(num, red, green, blue, intensity);
+}
+
+void blinkt_set_all_hsv(uint16_t hue, uint8_t sat, uint8_t val, float intensity) {
+	uint8_t red, green, blue;
+	blinkt_hsv_to_rgb(hue, sat, val, red, green, blue);
+	blinkt_set_all(red, green, blue, intensity);
+}
+
+void blinkt_fill_hue_gradient(unsigned first, unsigned num, uint16_t start_hue, int32_t step, float intensity) {
+	num = blinkt_clip_range(first, num);
+	blinkt_cancel_updates(first, num);
+
+	// Work on contiguous arrays covering the whole Blinkt, so that each
+	// pass is a fixed length loop the compiler can vectorise, and only
+	// interleave the results into the buffer at the end
+	uint32_t hue6[BLINKT_NUM_LEDS];
+	uint8_t bgr[3][BLINKT_NUM_LEDS];
+	for (unsigned n = 0; n < BLINKT_NUM_LEDS; n++) {
+		// Hue arithmetic wraps modulo a full turn
+		hue6[n] = (uint16_t)(start_hue + n * step) * 6u;
+	}
+	for (unsigned c = 0; c < 3; c++) {
+		uint32_t k = 2 * c + 1;		// blue, green, red
+		for (unsigned n = 0; n < BLINKT_NUM_LEDS; n++) {
+			bgr[c][n] = blinkt_hsv_channel(hue6[n], k, 255 * 255, 255);
+		}
+	}
+
+	uint8_t* p = BLINKT_BUFFER + (first * BLINKT_BYTES_PER_LED);
+	for (unsigned n = 0; n < num; n++, p += BLINKT_BYTES_PER_LED) {
+		p[1] = bgr[0][n];
+		p[2] = bgr[1][n];
+		p[3] = bgr[2][n];
+	}
+	blinkt_set_range_intensity(first, num, intensity);
+}
+
+void blinkt_fill_rgb_gradient(unsigned first, unsigned num,
+		uint8_t red1, uint8_t green1, uint8_t blue1,
+		uint8_t red2, uint8_t green2, uint8_t blue2,
+		float intensity) {
+	int32_t dr = red2 - red1, dg = green2 - green1, db = blue2 - blue1;
+	unsigned last = num > 1 ? num - 1 : 1;
+
+	num = blinkt_clip_range(first, num);
+	blinkt_cancel_updates(first, num);
+	uint8_t* p = BLINKT_BUFFER + (first * BLINKT_BYTES_PER_LED);
+	for (unsigned n = 0; n < num; n++, p += BLINKT_BYTES_PER_LED) {
+		// Position of this LED along the gradient in 16.16 fixed point
+		int32_t t = (int32_t)((n << 16) / last);
+		p[1] = (uint8_t)(blue1 + ((db * t + (1 << 15)) >> 16));
+		p[2] = (uint8_t)(green1 + ((dg * t + (1 << 15)) >> 16));
+		p[3] = (uint8_t)(red1 + ((dr * t + (1 << 15)) >> 16));
+	}
+	blinkt_set_range_intensity(first, num, intensity);
+}
+
+void blinkt_transition_led(unsigned num, uint8_t red, uint8_t green, uint8_t blue, float intensity,
+		uint32_t duration, unsigned easing, uint32_t now) {
+	if (num >= BLINKT_NUM_LEDS) {
+		return;
+	}
+
+	// Start from the interpolated value of any transition in progress,
+	// otherwise from what is in the buffer
+	blinkt_transition &tr = BLINKT_TRANSITIONS[num];
+	if (tr.active) {
+		(void) blinkt_transition_update(tr, now);
+	} else if (!tr.valid) {
+		uint8_t* p = BLINKT_BUFFER + (num * BLINKT_BYTES_PER_LED);
+		for (unsigned c = 0; c < BLINKT_BYTES_PER_LED; c++) {
+			tr.current[c] = p[c] << 8;
+		}
+	}
+	for (unsigned c = 0; c < BLINKT_BYTES_PER_LED; c++) {
+		tr.from[c] = tr.current[c];
+	}
+
+	tr.to[0] = intensity < 0.0 ? tr.from[0] :
+		(uint16_t)((BLINKT_INTENSITY_MAX << 8) * (intensity > 1.0 ? 1.0 : intensity));
+	tr.to[1] = blue << 8;
+	tr.to[2] = green << 8;
+	tr.to[3] = red << 8;
+	tr.easing = easing <= (unsigned)BLINKT_EASE_IN_OUT ? easing : (unsigned)BLINKT_EASE_LINEAR;
+	tr.start = now;
+	tr.duration = duration;
+	tr.active = true;
+	tr.valid = true;
+}
+
+void blinkt_transition_range(unsigned first, unsigned num, uint8_t red, uint8_t green, uint8_t blue,
+		float intensity, uint32_t duration, unsigned easing, uint32_t now) {
+	num = blinkt_clip_range(first, num);
+	for (unsigned n = first; n < first + num; n++) {
+		blinkt_transition_led(n, red, green, blue, intensity, duration, easing, now);
+	}
+}
+
+void blinkt_transition_all(uint8_t red, uint8_t green, uint8_t blue, float intensity,
+		uint32_t duration, unsigned easing, uint32_t now) {
+	blinkt_transition_range(0, BLINKT_NUM_LEDS, red, green, blue, intensity, duration, easing, now);
+}
+
+bool blinkt_transition_step(uint32_t now) {
+	bool busy = false;
+	uint8_t* p = BLINKT_BUFFER;
+	for (unsigned n = 0; n < BLINKT_NUM_LEDS; n++, p += BLINKT_BYTES_PER_LED) {
+		blinkt_transition &tr = BLINKT_TRANSITIONS[n];
+		if (!tr.active) {
+			continue;
+		}
+		tr.active = blinkt_transition_update(tr, now);
+		busy |= tr.active;
+		if (BLINKT_DITHER) {
+			// Hand the full precision value over to the dithering
+			// stage, combining colour and intensity
+			const uint64_t scale = (uint64_t)(255 << 8) * (BLINKT_INTENSITY_MAX << 8);
+			uint64_t i = tr.current[0];
+			blinkt_dither_target(n,
+				(uint16_t)((tr.current[3] * i * 0xffff) / scale),
+				(uint16_t)((tr.current[2] * i * 0xffff) / scale),
+				(uint16_t)((tr.current[1] * i * 0xffff) / scale));
+		} else {
+			for (unsigned c = 0; c < BLINKT_BYTES_PER_LED; c++) {
+				p[c] = (uint8_t)((tr.current[c] + 0x80) >> 8);
+			}
+		}
+	}
+	return busy;
+}
+
+bool blinkt_is_transitioning() {
+	for (unsigned n = 0; n < BLINKT_NUM_LEDS; n++) {
+		if (BLINKT_TRANSITIONS[n].active) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void blinkt_set_led16(unsigned num, uint16_t red, uint16_t green, uint16_t blue) {
+	if (num >= BLINKT_NUM_LEDS) {
+		return;
+	}
+	blinkt_cancel_updates(num, 1);
+	blinkt_dither_target(num, red, green, blue);
+}
+
+void blinkt_set_all16(uint16_t red, uint16_t green, uint16_t blue) {
+	for (unsigned i = 0; i < BLINKT_NUM_LEDS; i++) {
+		blinkt_set_led16(i, red, green, blue);
+	}
+}
+
+bool blinkt_dither_step() {
+	if (!BLINKT_DITHER) {
+		return false;
+	}
+	bool busy = false;
+	uint8_t* p = BLINKT_BUFFER;
+	for (unsigned n = 0; n < BLINKT_NUM_LEDS; n++, p += BLINKT_BYTES_PER_LED) {
+		blinkt_dither &d = BLINKT_DITHERS[n];
+		if (d.active) {
+			blinkt_dither_frame(d, p, true);
+			busy = true;
+		}
+	}
+	return busy;
+}
+
+bool blinkt_enable_dither(bool enable) {
+	bool ret = BLINKT_DITHER;
+	BLINKT_DITHER = enable;
+	if (!enable) {
+		// Leave dithered LEDs at their nearest undithered value
+		uint8_t* p = BLINKT_BUFFER;
+		for (unsigned n = 0; n < BLINKT_NUM_LEDS; n++, p += BLINKT_BYTES_PER_LED) {
+			blinkt_dither &d = BLINKT_DITHERS[n];
+			if (d.active) {
+				blinkt_dither_frame(d, p, false);
+				d.active = false;
+			}
+		}
+	}
+	return ret;
+}
+
+void blinkt_set_rgb24(unsigned first, unsigned num, const uint8_t* __restrict rgb, float intensity) {
+	num = blinkt_clip_range(first, num);
+	blinkt_cancel_updates(first, num);
+
+	// Write every byte of each LED, including the intensity even if it is
+	// unchanged, so that the stores have no gaps and can be vectorised
+	bool keep = intensity < 0.0;
+	uint8_t i = keep ? 0 : (uint8_t)(BLINKT_INTENSITY_MAX * (intensity > 1.0 ? 1.0 : intensity));
+	uint8_t* p = BLINKT_BUFFER + (first * BLINKT_BYTES_PER_LED);
+	for (unsigned n = 0; n < num; n++) {
+		p[4 * n] = keep ? p[4 * n] : i;	// intensity
+		p[4 * n + 1] = rgb[3 * n + 2];	// blue
+		p[4 * n + 2] = rgb[3 * n + 1];	// green
+		p[4 * n + 3] = rgb[3 * n];	// red
+	}
+}
+
+void blinkt_set_rgba32(unsigned first, unsigned num, const uint8_t* __restrict rgba) {
+	num = blinkt_clip_range(first, num);
+	blinkt_cancel_updates(first, num);
+	uint8_t* p = BLINKT_BUFFER + (first * BLINKT_BYTES_PER_LED);
+	for (unsigned n = 0; n < num; n++) {
+		// Scale alpha to 0-31 with rounding, without a division
+		p[4 * n] = (uint8_t)((rgba[4 * n + 3] * BLINKT_INTENSITY_MAX + 0x80) >> 8);
+		p[4 * n + 1] = rgba[4 * n + 2];	// blue
+		p[4 * n + 2] = rgba[4 * n + 1];	// green
+		p[4 * n + 3] = rgba[4 * n];	// red
+	}
+}
+
+void blinkt_set_ibgr(unsigned first, unsigned num, const uint8_t* __restrict ibgr) {
+	num = blinkt_clip_range(first, num);
+	blinkt_cancel_updates(first, num);
+	uint8_t* p = BLINKT_BUFFER + (first * BLINKT_BYTES_PER_LED);
+	for (unsigned i = 0; i < num * BLINKT_BYTES_PER_LED; i++) {
+		// Only the intensity bytes need masking
+		p[i] = ibgr[i] & ((i % BLINKT_BYTES_PER_LED) ? 0xff : BLINKT_INTENSITY_MAX);
+	}
+}
+
 bool blinkt_enable_debug(bool enable) {
 	bool ret = BLINKT_DEBUG;
 	BLINKT_DEBUG = enable;
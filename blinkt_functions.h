@@ -51,11 +51,13 @@
  * LEDs without affecting the intensity. Values greater than 1.0 are treated
  * as though they were 1.0, i.e. maximum intensity.
  *
- * The plugin keeps an internal colour/intensity state for each LED that is
- * only transferred to the real LEDs when the refresh() action is called. This
- * is the only way to change the state of the physical LEDs. The effects of
- * any number of preceding set*() and reset() actions will become visible only
- * when refresh() is called.
+ * This module keeps an internal colour/intensity state for each LED that is
+ * only transferred to the real LEDs when blinkt_refresh() is called. The
+ * effects of any number of preceding blinkt_set*() and blinkt_reset() calls
+ * will become visible only when blinkt_refresh() is called. Note that callers
+ * running transitions or dithering, such as the BlinktPlugin's output clock,
+ * call blinkt_refresh() on every frame, which also makes any other pending
+ * changes visible.
  *
  * For more information on the Blinkt! hardware and other language APIs see:
  * https://github.com/pimoroni/blinkt (Blinkt! GitHub project)
@@ -127,6 +129,268 @@ void blinkt_set_intensity(unsigned num, float intensity);
  */
 void blinkt_set_intensity(float intensity);
 
+/**
+ * Convert an HSV (hue, saturation, value) colour to RGB. The conversion uses
+ * only integer arithmetic and min/max operations, with no branching on the
+ * hue sector, so that it can be vectorised when applied to several LEDs.
+ *
+ * Hue is a fraction of a full turn of the colour wheel in units of 1/65536,
+ * so zero is red, 21845 is green, 43690 is blue and values wrap around
+ * naturally on overflow.
+ *
+ * @param hue The hue component of the HSV colour value.
+ * @param sat The saturation component of the HSV colour value (0-255).
+ * @param val The value component of the HSV colour value (0-255).
+ * @param red Set to the red component of the equivalent RGB colour value.
+ * @param green Set to the green component of the equivalent RGB colour value.
+ * @param blue Set to the blue component of the equivalent RGB colour value.
+ */
+void blinkt_hsv_to_rgb(uint16_t hue, uint8_t sat, uint8_t val, uint8_t &red, uint8_t &green, uint8_t &blue);
+
+/**
+ * Set the colour of a Blinkt! LED from an HSV colour value, and optionally
+ * its intensity. See blinkt_hsv_to_rgb() for the representation of the HSV
+ * components. This function just changes internal state. Use the refresh()
+ * function to actually update the Blinkt! LEDs.
+ *
+ * @param num The LED number to set, starting from zero.
+ * @param hue The hue component of the HSV colour value.
+ * @param sat The saturation component of the HSV colour value.
+ * @param val The value component of the HSV colour value.
+ * @param intensity The global intensity of the LED (optional).
+ */
+void blinkt_set_led_hsv(unsigned num, uint16_t hue, uint8_t sat, uint8_t val, float intensity = -1.0);
+
+/**
+ * Set the colour of all Blinkt! LEDs from an HSV colour value, and optionally
+ * their intensity. See blinkt_hsv_to_rgb() for the representation of the HSV
+ * components. This function just changes internal state. Use the refresh()
+ * function to actually update the Blinkt! LEDs.
+ *
+ * @param hue The hue component of the HSV colour value.
+ * @param sat The saturation component of the HSV colour value.
+ * @param val The value component of the HSV colour value.
+ * @param intensity The global intensity of the LEDs (optional).
+ */
+void blinkt_set_all_hsv(uint16_t hue, uint8_t sat, uint8_t val, float intensity = -1.0);
+
+/**
+ * Fill a contiguous range of Blinkt! LEDs with fully saturated colours whose
+ * hue changes by a fixed step from each LED to the next, wrapping around the
+ * colour wheel as necessary. A negative step runs the hue backwards. LEDs
+ * beyond the end of the Blinkt! are ignored. This function just changes
+ * internal state. Use the refresh() function to actually update the Blinkt!
+ * LEDs.
+ *
+ * @param first The leftmost LED to set, starting from zero.
+ * @param num The number of LEDs to set.
+ * @param start_hue The hue of the first LED, as for blinkt_hsv_to_rgb().
+ * @param step The change in hue between adjacent LEDs.
+ * @param intensity The global intensity of the LEDs (optional).
+ */
+void blinkt_fill_hue_gradient(unsigned first, unsigned num, uint16_t start_hue, int32_t step, float intensity = -1.0);
+
+/**
+ * Fill a contiguous range of Blinkt! LEDs with a linear RGB gradient from a
+ * start colour on the first LED to an end colour on the last LED. LEDs beyond
+ * the end of the Blinkt! are ignored, although they are still used to
+ * calculate the gradient. This function just changes internal state. Use the
+ * refresh() function to actually update the Blinkt! LEDs.
+ *
+ * @param first The leftmost LED to set, starting from zero.
+ * @param num The number of LEDs in the gradient.
+ * @param red1 The red component of the start colour.
+ * @param green1 The green component of the start colour.
+ * @param blue1 The blue component of the start colour.
+ * @param red2 The red component of the end colour.
+ * @param green2 The green component of the end colour.
+ * @param blue2 The blue component of the end colour.
+ * @param intensity The global intensity of the LEDs (optional).
+ */
+void blinkt_fill_rgb_gradient(unsigned first, unsigned num,
+		uint8_t red1, uint8_t green1, uint8_t blue1,
+		uint8_t red2, uint8_t green2, uint8_t blue2,
+		float intensity = -1.0);
+
+/**
+ * Easing curves for LED transitions. Curves are evaluated in 16.16 fixed
+ * point.
+ */
+enum blinkt_easing {
+	BLINKT_EASE_LINEAR = 0,		// Constant rate of change
+	BLINKT_EASE_IN = 1,		// Start slowly then accelerate (quadratic)
+	BLINKT_EASE_OUT = 2,		// Start quickly then decelerate (quadratic)
+	BLINKT_EASE_IN_OUT = 3		// Start and finish slowly (smoothstep)
+};
+
+/**
+ * Start a timed transition of a Blinkt! LED from its current colour and
+ * intensity to a new target. If the LED already has a transition in progress
+ * the new transition starts from the current interpolated value, so targets
+ * can be changed at any time without jumps. The transition is only applied
+ * to the internal state by blinkt_transition_step(), which should be called
+ * regularly followed by refresh(). Any blinkt_set*(), blinkt_fill*() or
+ * blinkt_reset() call affecting the LED cancels its transition.
+ *
+ * @param num The LED number to set, starting from zero.
+ * @param red The red component of the target RGB colour value.
+ * @param green The green component of the target RGB colour value.
+ * @param blue The blue component of the target RGB colour value.
+ * @param intensity The target global intensity of the LED. If less than
+ * zero the intensity is left unchanged.
+ * @param duration The duration of the transition in milliseconds.
+ * @param easing The easing curve of the transition, see blinkt_easing.
+ * Unknown values are treated as BLINKT_EASE_LINEAR.
+ * @param now The current time in milliseconds, as returned by millis().
+ */
+void blinkt_transition_led(unsigned num, uint8_t red, uint8_t green, uint8_t blue, float intensity,
+		uint32_t duration, unsigned easing, uint32_t now);
+
+/**
+ * Start a timed transition of a contiguous range of Blinkt! LEDs to a new
+ * colour and intensity. LEDs beyond the end of the Blinkt! are ignored. See
+ * blinkt_transition_led() for details.
+ *
+ * @param first The leftmost LED to set, starting from zero.
+ * @param num The number of LEDs to set.
+ * @param red The red component of the target RGB colour value.
+ * @param green The green component of the target RGB colour value.
+ * @param blue The blue component of the target RGB colour value.
+ * @param intensity The target global intensity of the LEDs.
+ * @param duration The duration of the transition in milliseconds.
+ * @param easing The easing curve of the transition, see blinkt_easing.
+ * @param now The current time in milliseconds, as returned by millis().
+ */
+void blinkt_transition_range(unsigned first, unsigned num, uint8_t red, uint8_t green, uint8_t blue,
+		float intensity, uint32_t duration, unsigned easing, uint32_t now);
+
+/**
+ * Start a timed transition of all Blinkt! LEDs to a new colour and
+ * intensity. See blinkt_transition_led() for details.
+ *
+ * @param red The red component of the target RGB colour value.
+ * @param green The green component of the target RGB colour value.
+ * @param blue The blue component of the target RGB colour value.
+ * @param intensity The target global intensity of the LEDs.
+ * @param duration The duration of the transition in milliseconds.
+ * @param easing The easing curve of the transition, see blinkt_easing.
+ * @param now The current time in milliseconds, as returned by millis().
+ */
+void blinkt_transition_all(uint8_t red, uint8_t green, uint8_t blue, float intensity,
+		uint32_t duration, unsigned easing, uint32_t now);
+
+/**
+ * Advance all transitions in progress to the given time, updating the
+ * internal colour and intensity state of the affected LEDs. Use the refresh()
+ * function to actually update the Blinkt! LEDs.
+ *
+ * @param now The current time in milliseconds, as returned by millis().
+ * @return True if any transitions are still in progress.
+ */
+bool blinkt_transition_step(uint32_t now);
+
+/**
+ * Check whether any transitions are in progress, i.e. have been started and
+ * have neither been completed by blinkt_transition_step() nor cancelled.
+ *
+ * @return True if any transitions are in progress.
+ */
+bool blinkt_is_transitioning();
+
+/**
+ * Set a Blinkt! LED to a 16-bit per channel linear output level, where 65535
+ * is the full colour value at maximum intensity. The global intensity and
+ * colour values sent to the LED are chosen automatically to best approximate
+ * the target. If dithering is enabled (see blinkt_enable_dither()) the LED
+ * is handed over to the dithering stage, which approximates the target over
+ * successive frames, otherwise the nearest single value is used. This
+ * function just changes internal state. Use the refresh() function to
+ * actually update the Blinkt! LEDs.
+ *
+ * @param num The LED number to set, starting from zero.
+ * @param red The red output level.
+ * @param green The green output level.
+ * @param blue The blue output level.
+ */
+void blinkt_set_led16(unsigned num, uint16_t red, uint16_t green, uint16_t blue);
+
+/**
+ * Set all Blinkt! LEDs to a 16-bit per channel linear output level. See
+ * blinkt_set_led16() for details.
+ *
+ * @param red The red output level.
+ * @param green The green output level.
+ * @param blue The blue output level.
+ */
+void blinkt_set_all16(uint16_t red, uint16_t green, uint16_t blue);
+
+/**
+ * Calculate the next dithered frame for all LEDs under the control of the
+ * dithering stage, i.e. those set by blinkt_set_led16() or by transitions
+ * while dithering is enabled. The error between the target and the value
+ * actually sent is carried over from frame to frame, so this should be
+ * called followed by refresh() at a high and steady frame rate, after
+ * blinkt_transition_step() if transitions are also being used. LEDs whose
+ * target can be shown exactly without dithering, including zero, are set
+ * directly and don't count as being dithered.
+ *
+ * @return True if any LEDs are being dithered.
+ */
+bool blinkt_dither_step();
+
+/**
+ * Enable or disable the dithering stage. When enabled, LEDs set by
+ * blinkt_set_led16() and transitions are approximated at higher colour
+ * depth by blinkt_dither_step(). When disabled, any dithered LEDs are left
+ * at the nearest undithered value.
+ *
+ * @param enable True to enable dithering, false to disable it.
+ * @return The previous value of the dithering flag.
+ */
+bool blinkt_enable_dither(bool enable);
+
+/**
+ * Set the colour of a contiguous range of Blinkt! LEDs from packed 24-bit
+ * RGB pixel data, three bytes per LED in R, G, B order, and optionally their
+ * intensity. LEDs beyond the end of the Blinkt! are ignored. This function
+ * just changes internal state. Use the refresh() function to actually update
+ * the Blinkt! LEDs.
+ *
+ * @param first The leftmost LED to set, starting from zero.
+ * @param num The number of LEDs to set.
+ * @param rgb Pointer to the pixel data for the first LED.
+ * @param intensity The global intensity of the LEDs (optional).
+ */
+void blinkt_set_rgb24(unsigned first, unsigned num, const uint8_t* __restrict rgb, float intensity = -1.0);
+
+/**
+ * Set the colour and intensity of a contiguous range of Blinkt! LEDs from
+ * packed 32-bit RGBA pixel data, four bytes per LED in R, G, B, A order. The
+ * alpha channel is used as the intensity of the LED, scaled from 0-255 to the
+ * range supported by the hardware. LEDs beyond the end of the Blinkt! are
+ * ignored. This function just changes internal state. Use the refresh()
+ * function to actually update the Blinkt! LEDs.
+ *
+ * @param first The leftmost LED to set, starting from zero.
+ * @param num The number of LEDs to set.
+ * @param rgba Pointer to the pixel data for the first LED.
+ */
+void blinkt_set_rgba32(unsigned first, unsigned num, const uint8_t* __restrict rgba);
+
+/**
+ * Set the colour and intensity of a contiguous range of Blinkt! LEDs from
+ * pixel data in the native APA102 format, four bytes per LED in I, B, G, R
+ * order where I is the 5-bit global intensity (0-31, higher bits ignored).
+ * LEDs beyond the end of the Blinkt! are ignored. This function just changes
+ * internal state. Use the refresh() function to actually update the Blinkt!
+ * LEDs.
+ *
+ * @param first The leftmost LED to set, starting from zero.
+ * @param num The number of LEDs to set.
+ * @param ibgr Pointer to the pixel data for the first LED.
+ */
+void blinkt_set_ibgr(unsigned first, unsigned num, const uint8_t* __restrict ibgr);
+
 /**
  * Update all the Blinkt! LEDs to match the internal colour and intensity
  * state, making the effects of all previous blinkt_set*() calls visible.
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2016-2017 Scott Mitchell.
+ * All rights reserved.
+ *
+ * Licenced under the BSD 3-Clause licence (the "Licence"); you may not use
+ * this file except in compliance with the Licence. You may obtain a copy of
+ * the Licence from the LICENCE file in the top level of this software
+ * distribution or from:
+ *
+ *	 https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _BLINKT_LOCK_H
+#define _BLINKT_LOCK_H
+
+#include <mutex>
+
+
+/**
+ * Lock for the internal Blinkt! state kept by blinkt_functions. Those
+ * functions do no locking of their own, so multi-threaded callers such as the
+ * BlinktPlugin and BlinktTransport must hold this lock while calling them.
+ * Single-threaded programs such as blinkt_test don't use it, and so don't
+ * need to be built as C++11.
+ */
+extern std::mutex BLINKT_MUTEX;
+
+#endif // _BLINKT_LOCK_H
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2016-2020 Scott Mitchell.
+ * All rights reserved.
+ *
+ * Licenced under the BSD 3-Clause licence (the "Licence"); you may not use
+ * this file except in compliance with the Licence. You may obtain a copy of
+ * the Licence from the LICENCE file in the top level of this software
+ * distribution or from:
+ *
+ *	 https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Display a continuous stream of raw frames on the Blinkt, read from stdin or
+ * a named pipe. Each frame holds one pixel per LED, from left to right, in
+ * one of these formats:
+ *
+ *   rgb24  - 3 bytes per LED, R G B (intensity set by -i)
+ *   rgba32 - 4 bytes per LED, R G B A (alpha used as intensity)
+ *   ibgr   - 4 bytes per LED, I B G R (native APA102 format, I = 0-31)
+ *
+ * Output is paced to a target frame rate. If the producer sends frames
+ * faster than this, only the most recent complete frame is shown at each
+ * tick and the older ones are dropped. Throughput is reported on stderr on
+ * exit, which happens at end of input or on SIGINT/SIGTERM.
+ *
+ * Assumes that "blinkt_setup" or equivalent has been run.
+ */
+
+#include "blinkt_functions.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <wiringPi.h>
+
+// Maximum number of frames buffered between output ticks
+static const unsigned MAX_FRAMES = 64;
+
+static volatile sig_atomic_t STOP = 0;
+
+static void stop_handler(int) {
+	STOP = 1;
+}
+
+static double now_secs() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char* prog) {
+	fprintf(stderr, "Usage: %s [-f rgb24|rgba32|ibgr] [-r fps] [-i intensity] [-k] [file]\n", prog);
+	fprintf(stderr, "  -f  Input pixel format (default rgb24)\n");
+	fprintf(stderr, "  -r  Target output frame rate (default 100)\n");
+	fprintf(stderr, "  -i  Intensity for rgb24 input, 0.0-1.0 (default 1.0)\n");
+	fprintf(stderr, "  -k  Keep the last frame displayed on exit\n");
+	fprintf(stderr, "  file  File or named pipe to read (default stdin)\n");
+	exit(1);
+}
+
+int main(int argc, char** argv) {
+
+	enum { RGB24, RGBA32, IBGR } format = RGB24;
+	unsigned bytes_per_led = 3;
+	double fps = 100.0;
+	float intensity = 1.0;
+	bool keep = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "f:r:i:k")) != -1) {
+		switch (opt) {
+		case 'f':
+			if (strcmp(optarg, "rgb24") == 0) {
+				format = RGB24;
+				bytes_per_led = 3;
+			} else if (strcmp(optarg, "rgba32") == 0) {
+				format = RGBA32;
+				bytes_per_led = 4;
+			} else if (strcmp(optarg, "ibgr") == 0) {
+				format = IBGR;
+				bytes_per_led = 4;
+			} else {
+				usage(argv[0]);
+			}
+			break;
+		case 'r':
+			fps = atof(optarg);
+			if (fps <= 0.0) {
+				usage(argv[0]);
+			}
+			break;
+		case 'i':
+			intensity = atof(optarg);
+			break;
+		case 'k':
+			keep = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind < argc - 1) {
+		usage(argv[0]);
+	}
+
+	// Opening a named pipe blocks until the producer opens it for writing.
+	// After that every read is preceded by a poll with a timeout, so that
+	// we never wait past an output tick. The descriptor is left blocking,
+	// since stdin may be shared with the shell or other pipeline stages.
+	int fd = STDIN_FILENO;
+	if (optind == argc - 1 && strcmp(argv[optind], "-") != 0) {
+		fd = open(argv[optind], O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+			exit(1);
+		}
+	}
+
+	signal(SIGINT, stop_handler);
+	signal(SIGTERM, stop_handler);
+	signal(SIGPIPE, SIG_IGN);
+
+	(void) wiringPiSetupSys();
+
+	const unsigned frame_size = bytes_per_led * BLINKT_NUM_LEDS;
+	const unsigned buffer_size = frame_size * MAX_FRAMES;
+	uint8_t* buffer = (uint8_t*)malloc(buffer_size);
+	uint8_t* latest = (uint8_t*)malloc(frame_size);
+	if (buffer == NULL || latest == NULL) {
+		fprintf(stderr, "Failed to allocate frame buffers\n");
+		exit(1);
+	}
+	unsigned fill = 0;
+
+	unsigned long frames_read = 0, frames_shown = 0, frames_dropped = 0;
+	unsigned long long bytes_read = 0;
+	unsigned pending = 0;
+	bool eof = false;
+
+	const double period = 1.0 / fps;
+	double start = now_secs();
+	double next = start + period;
+
+	while (!STOP && !(eof && pending == 0)) {
+
+		// Read whatever is available until the next output tick
+		double now = now_secs();
+		while (!eof && !STOP && now < next) {
+			struct pollfd pfd = { fd, POLLIN, 0 };
+			int timeout = (int)((next - now) * 1000.0) + 1;
+			if (poll(&pfd, 1, timeout) > 0) {
+				ssize_t n = read(fd, buffer + fill, buffer_size - fill);
+				if (n > 0) {
+					bytes_read += n;
+					fill += n;
+
+					// Keep only the most recent complete frame
+					unsigned complete = fill / frame_size;
+					if (complete > 0) {
+						memcpy(latest, buffer + (complete - 1) * frame_size, frame_size);
+						frames_read += complete;
+						pending += complete;
+						fill -= complete * frame_size;
+						memmove(buffer, buffer + complete * frame_size, fill);
+					}
+				} else if (n == 0 || errno != EINTR) {
+					// End of input, or all writers have closed the pipe
+					eof = true;
+				}
+			}
+			now = now_secs();
+		}
+
+		// Show the latest frame, dropping any stale ones before it
+		if (pending > 0) {
+			switch (format) {
+			case RGB24:
+				blinkt_set_rgb24(0, BLINKT_NUM_LEDS, latest, intensity);
+				break;
+			case RGBA32:
+				blinkt_set_rgba32(0, BLINKT_NUM_LEDS, latest);
+				break;
+			case IBGR:
+				blinkt_set_ibgr(0, BLINKT_NUM_LEDS, latest);
+				break;
+			}
+			blinkt_refresh();
+			frames_shown++;
+			frames_dropped += pending - 1;
+			pending = 0;
+		}
+
+		// Keep a steady cadence unless we have fallen behind
+		next += period;
+		if (next < now) {
+			next = now + period;
+		}
+	}
+
+	double elapsed = now_secs() - start;
+
+	if (!keep) {
+		blinkt_reset();
+		blinkt_refresh();
+	}
+
+	fprintf(stderr, "blinkt_stream: %.2f seconds\n", elapsed);
+	fprintf(stderr, "  frames read:    %lu (%.1f fps, %.1f KB/s)\n",
+		frames_read, frames_read / elapsed, bytes_read / elapsed / 1024.0);
+	fprintf(stderr, "  frames shown:   %lu (%.1f fps)\n", frames_shown, frames_shown / elapsed);
+	fprintf(stderr, "  frames dropped: %lu\n", frames_dropped);
+	if (fill > 0) {
+		fprintf(stderr, "  partial frame:  %u bytes discarded\n", fill);
+	}
+
+	free(buffer);
+	free(latest);
+	exit(0);
+}
@@ -29,9 +29,14 @@ ApamaHomeMonitors = join(PROJECT.APAMA_HOME, 'monitors')
 ApamaWorkMonitors = join(PROJECT.APAMA_WORK, 'monitors')
 BlinktTestObjects = join(PROJECT.ROOTDIR, 'objects')
 BlinktProjectDir = join(PROJECT.ROOTDIR, '..')
+BlinktTransportConfig = join(BlinktProjectDir, 'BlinktTransport.yaml')
 
 class BlinktBaseTest(BaseTest):
 
+	# Optional list of correlator configuration files, for example
+	# connectivity chain definitions, to start the correlator with.
+	correlatorConfig = None
+
 	def __init__(self, descriptor, outdir, runner):
 		BaseTest.__init__(self, descriptor, outdir, runner)
 
@@ -45,7 +50,7 @@ class BlinktBaseTest(BaseTest):
 		# Initialise a correlator with the Blinkt plugin, the plugin
 		# wrapper and other required supporting code.
 		self.correlator = CorrelatorHelper(self, name='BlinktCorrelator')
-		process = self.correlator.start()
+		process = self.correlator.start(config=self.correlatorConfig)
 		self.correlatorLog = process.stdout
 		self.correlatorOut = process.stdout
 		self.correlatorErr = process.stderr